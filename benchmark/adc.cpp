@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "benchmark.h"
+
+AKAT_DECLARE(/* cpu_frequency = */              8000000,
+             /* tasks = */                      8,
+             /* dispatcher_idle_code = */       ,
+             /* dispatcher_overflow_code = */   )
+
+#ifdef ADCSRA
+
+static uint8_t blocks;
+static uint8_t ok = 1;
+
+AKAT_ADC(/* name = */                           adc,
+         /* oversampling_log2 = */              2,
+         /* block = */                          4,
+         /* admux = */                          0,
+         /* prescaler = */                      _BV(ADPS2) | _BV(ADPS1),
+         /* block_task = */                     adc_task,
+         /* channels = */                       0, 1)
+
+static void adc_task () {
+    BENCH
+
+    const uint16_t *block = adc.get_block ();
+
+    // check.c feeds full scale (1023) into channel 0 and a single full scale sample
+    // out of each 16 into channel 1: 16 * 1023 / 4 = 4092 and 1023 / 4 = 255.75 -> 256.
+    for (uint8_t i = 0; i < adc.readings; i += adc.channels) {
+        if (block[i] != 4092 || block[i + 1] != 256) {
+            ok = 0;
+        }
+    }
+
+    adc.release ();
+
+    BENCH
+
+    if (++blocks == 3) {
+        adc.stop ();
+        BENCH_CHECK (ok)
+        BENCH_EXIT
+    }
+}
+
+__ATTR_NORETURN__
+void main () {
+    akat_init ();
+
+    BENCH_INIT
+
+    BENCH
+
+    adc.start ();
+    sei ();
+
+    BENCH
+
+    akat_dispatcher_loop ();
+}
+
+#else
+
+void main () {
+    BENCH_INIT
+
+    BENCH
+
+    BENCH_EXIT
+}
+
+#endif
@@ -8,11 +8,17 @@
 #ifndef AKAT_BENCHMARK_H_
 #define AKAT_BENCHMARK_H_
 
-#define BENCH_INIT      DDRB = 0x3;
+#define BENCH_INIT      DDRB = 0x7;
 
 #define BENCH_EXIT      PORTB = 2;
 
 #define BENCH           PORTB = 1; \
                         PORTB = 0;
 
+// Reports result of a self check to the check harness (check.c) by raising PB2.
+// Must be used right before BENCH_EXIT.
+#define BENCH_CHECK(ok) if (ok) {           \
+                            PORTB |= 4;     \
+                        }
+
 #endif
@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////
+// Useful functions for rapid development for AVR microcontrollers.
+// 2010 (C) Akshaal
+// http://www.akshaal.info    or    http://rus.akshaal.info
+// GNU GPL
+///////////////////////////////////////////////////////////////////
+
+// Check harness. Runs a benchmark firmware in simavr with stimulus that the
+// python binding can't provide and reports the self check result of the firmware.
+// Firmware raises PB2 (BENCH_CHECK) if check passed and PB1 (BENCH_EXIT) when done.
+// Parts for peripherals that the mcu doesn't have are skipped.
+//
+// Usage: check <mcu> <firmware> <part>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "avr_ioport.h"
+#include "avr_adc.h"
+#include "avr_twi.h"
+
+#define CHECK_FREQ      8000000
+#define CHECK_VREF      5000
+#define CHECK_CYCLES    50000000
+
+static int exited;
+static int passed;
+
+static void on_exit_pin (struct avr_irq_t *irq, uint32_t value, void *param) {
+    if (value) {
+        exited = 1;
+    }
+}
+
+static void on_check_pin (struct avr_irq_t *irq, uint32_t value, void *param) {
+    if (value) {
+        passed = 1;
+    }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// ADC: channel 0 is at full scale, channel 1 is at full scale for one sample out of 16
+// (first sample of each reading when oversampling_log2 = 2) and at 0 otherwise.
+
+static avr_irq_t *adc_channel1;
+static uint32_t adc_channel1_samples;
+
+static void on_adc_trigger (struct avr_irq_t *irq, uint32_t value, void *param) {
+    avr_adc_mux_t mux = {.v = value};
+
+    if (mux.src == 1) {
+        avr_raise_irq (adc_channel1, (adc_channel1_samples++ % 16) ? 0 : CHECK_VREF);
+    }
+}
+
+static int setup_adc (avr_t *avr) {
+    adc_channel1 = avr_io_getirq (avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC1);
+    if (!adc_channel1) {
+        return 0;
+    }
+
+    avr_raise_irq (avr_io_getirq (avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0), CHECK_VREF);
+    avr_raise_irq (adc_channel1, 0);
+
+    avr_irq_register_notify (avr_io_getirq (avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_OUT_TRIGGER),
+                             on_adc_trigger, NULL);
+
+    return 1;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// TWI: EEPROM-like slave at 0x50. First byte written after START is a memory address,
+// next written bytes are stored from that address, read bytes are taken from that address.
+
+#define TWI_SLAVE_ADDRESS       0x50
+
+static avr_irq_t *twi_slave_irq;
+static uint8_t twi_slave_memory[256];
+static uint8_t twi_slave_pointer;
+static int twi_slave_selected;
+static int twi_slave_written;
+
+static void on_twi_message (struct avr_irq_t *irq, uint32_t value, void *param) {
+    avr_twi_msg_irq_t v = {.u.v = value};
+
+    if (v.u.twi.msg & TWI_COND_STOP) {
+        twi_slave_selected = 0;
+    }
+
+    if (v.u.twi.msg & TWI_COND_START) {
+        twi_slave_selected = (v.u.twi.addr >> 1) == TWI_SLAVE_ADDRESS;
+        twi_slave_written = 0;
+
+        if (twi_slave_selected) {
+            avr_raise_irq (twi_slave_irq + TWI_IRQ_INPUT, avr_twi_irq_msg (TWI_COND_ACK, v.u.twi.addr, 1));
+        }
+    }
+
+    if (!twi_slave_selected) {
+        return;
+    }
+
+    if (v.u.twi.msg & TWI_COND_WRITE) {
+        avr_raise_irq (twi_slave_irq + TWI_IRQ_INPUT, avr_twi_irq_msg (TWI_COND_ACK, v.u.twi.addr, 1));
+
+        if (twi_slave_written++) {
+            twi_slave_memory[twi_slave_pointer++] = v.u.twi.data;
+        } else {
+            twi_slave_pointer = v.u.twi.data;
+        }
+    }
+
+    if (v.u.twi.msg & TWI_COND_READ) {
+        avr_raise_irq (twi_slave_irq + TWI_IRQ_INPUT,
+                       avr_twi_irq_msg (TWI_COND_READ, v.u.twi.addr, twi_slave_memory[twi_slave_pointer++]));
+    }
+}
+
+static int setup_twi (avr_t *avr) {
+    static const char *names[] = {"twi.slave.in", "twi.slave.out"};
+
+    avr_irq_t *master_in = avr_io_getirq (avr, AVR_IOCTL_TWI_GETIRQ (0), TWI_IRQ_INPUT);
+    if (!master_in) {
+        return 0;
+    }
+
+    twi_slave_irq = avr_alloc_irq (&avr->irq_pool, 0, 2, names);
+    avr_irq_register_notify (twi_slave_irq + TWI_IRQ_OUTPUT, on_twi_message, NULL);
+
+    avr_connect_irq (twi_slave_irq + TWI_IRQ_INPUT, master_in);
+    avr_connect_irq (avr_io_getirq (avr, AVR_IOCTL_TWI_GETIRQ (0), TWI_IRQ_OUTPUT),
+                     twi_slave_irq + TWI_IRQ_OUTPUT);
+
+    return 1;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+int main (int argc, char **argv) {
+    if (argc != 4) {
+        fprintf (stderr, "Usage: %s <mcu> <firmware> <part>\n", argv[0]);
+        return 2;
+    }
+
+    const char *mcu = argv[1];
+    const char *part = argv[3];
+
+    elf_firmware_t firmware;
+    memset (&firmware, 0, sizeof (firmware));
+
+    if (elf_read_firmware (argv[2], &firmware)) {
+        fprintf (stderr, "Unable to read %s\n", argv[2]);
+        return 2;
+    }
+
+    avr_t *avr = avr_make_mcu_by_name (mcu);
+    if (!avr) {
+        fprintf (stderr, "Unknown mcu %s\n", mcu);
+        return 2;
+    }
+
+    avr_init (avr);
+    avr_load_firmware (avr, &firmware);
+    avr->frequency = CHECK_FREQ;
+    avr->vcc = avr->avcc = avr->aref = CHECK_VREF;
+    avr->log = LOG_NONE;
+
+    avr_irq_register_notify (avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ ('B'), 1), on_exit_pin, NULL);
+    avr_irq_register_notify (avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ ('B'), 2), on_check_pin, NULL);
+
+    int supported;
+
+    if (!strcmp (part, "adc")) {
+        supported = setup_adc (avr);
+    } else if (!strcmp (part, "twi")) {
+        supported = setup_twi (avr);
+    } else if (!strcmp (part, "eeprom")) {
+        // No stimulus, simavr models EEPROM itself
+        supported = 1;
+    } else {
+        fprintf (stderr, "No check for %s\n", part);
+        return 2;
+    }
+
+    if (!supported) {
+        printf ("%s %s: not supported by mcu\n", mcu, part);
+        return 0;
+    }
+
+    int state = cpu_Running;
+
+    while (!exited && avr->cycle < CHECK_CYCLES && state != cpu_Done && state != cpu_Crashed) {
+        state = avr_run (avr);
+    }
+
+    printf ("%s %s: %s\n", mcu, part, !exited ? "TIMEOUT" : passed ? "ok" : "FAILED");
+
+    return exited && passed ? 0 : 1;
+}
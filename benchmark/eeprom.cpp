@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "benchmark.h"
+
+AKAT_DECLARE(/* cpu_frequency = */              8000000,
+             /* tasks = */                      8,
+             /* dispatcher_idle_code = */       ,
+             /* dispatcher_overflow_code = */   )
+
+AKAT_EEPROM(/* name = */                        eeprom,
+            /* queue_size = */                  4,
+            /* flush_task = */                  flushed)
+
+static volatile uint8_t value;
+static uint8_t discarded;
+static uint8_t flushes;
+static uint8_t checked;
+
+static void flushed () {
+    BENCH
+    value = eeprom.read (1);
+
+    BENCH
+
+    if (!flushes++) {
+        // simavr EEPROM is erased (0xFF) at start, so all 4 bytes are written
+        checked = !discarded && eeprom.get_writes () == 4 && value == 0x33
+                  && eeprom.read (2) == 0x22 && eeprom.read (3) == 0x44 && eeprom.read (4) == 0x55;
+
+        // Unchanged bytes must be skipped, only address 6 is written
+        discarded |= eeprom.write (2, 0x22);
+        discarded |= eeprom.write (5, 0xFF);
+        discarded |= eeprom.write (6, 0x66);
+
+        // Served from the queue while pending or being written
+        checked &= eeprom.read (6) == 0x66;
+        return;
+    }
+
+    BENCH_CHECK (checked && !discarded && eeprom.get_writes () == 5 && !eeprom.get_lost_flushes ()
+                 && eeprom.read (2) == 0x22 && eeprom.read (5) == 0xFF && eeprom.read (6) == 0x66)
+
+    BENCH_EXIT
+}
+
+__ATTR_NORETURN__
+void main () {
+    akat_init ();
+
+    BENCH_INIT
+
+    BENCH
+    discarded |= eeprom.write (1, 0x11);
+
+    BENCH
+    discarded |= eeprom.write (2, 0x22);
+
+    BENCH
+    discarded |= eeprom.write (1, 0x33);
+
+    BENCH
+    value = eeprom.read (1);
+
+    // Queue of 4 bytes takes 4 different addresses
+    discarded |= eeprom.write (3, 0x44);
+    discarded |= eeprom.write (4, 0x55);
+
+    BENCH
+
+    sei ();
+    akat_dispatcher_loop ();
+}
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "benchmark.h"
+
+// Load generator. Timer0 compare match interrupt posts a task every LOAD_PERIOD cycles,
+// each task burns LOAD_WORK cycles. LOAD_EVENTS tasks are posted, then program exits
+// when the queue is drained. Events are signalled with pulses on PORTB pins (see load.py):
+//   PB0 - task is posted, PB1 - exit, PB2 - task is started, PB3 - task is dropped.
+
+#ifndef LOAD_TASKS
+#define LOAD_TASKS      8
+#endif
+
+#ifndef LOAD_PERIOD
+#define LOAD_PERIOD     512
+#endif
+
+#ifndef LOAD_WORK
+#define LOAD_WORK       200
+#endif
+
+#ifndef LOAD_EVENTS
+#define LOAD_EVENTS     2000
+#endif
+
+static_assert(LOAD_PERIOD % 8 == 0 && LOAD_PERIOD >= 8 && LOAD_PERIOD <= 2048,
+              "LOAD_PERIOD must be a multiple of 8 in range 8..2048 cycles");
+
+static_assert(LOAD_EVENTS > 0 && LOAD_EVENTS <= 65535, "LOAD_EVENTS must be in range 1..65535");
+
+// Timer0 in CTC mode with prescaler 8, so the period doesn't depend on interrupt latency
+#ifdef TCCR0B
+#define LOAD_TIMER_START()  TCCR0A = _BV(WGM01);        \
+                            OCR0A = LOAD_PERIOD / 8 - 1; \
+                            TCCR0B = _BV(CS01);
+#define LOAD_TIMER_STOP()   TCCR0B = 0;
+#define LOAD_TIMER_vect     TIMER0_COMPA_vect
+#define LOAD_OCIE           OCIE0A
+#else
+#define LOAD_TIMER_START()  OCR0 = LOAD_PERIOD / 8 - 1;  \
+                            TCCR0 = _BV(WGM01) | _BV(CS01);
+#define LOAD_TIMER_STOP()   TCCR0 = 0;
+#define LOAD_TIMER_vect     TIMER0_COMP_vect
+#define LOAD_OCIE           OCIE0
+#endif
+
+#ifdef TIMSK0
+#define LOAD_TIMSK      TIMSK0
+#else
+#define LOAD_TIMSK      TIMSK
+#endif
+
+#define LOAD_PULSE(bit)     PORTB |= _BV(bit); \
+                            PORTB &= ~_BV(bit);
+
+static uint16_t events_left = LOAD_EVENTS;
+static volatile uint8_t posting_done;
+
+static void idle (void) {
+    if (posting_done) {
+        BENCH_EXIT
+    }
+}
+
+AKAT_DECLARE(/* cpu_frequency = */              8000000,
+             /* tasks = */                      LOAD_TASKS,
+             /* dispatcher_idle_code = */       idle(),
+             /* dispatcher_overflow_code = */   LOAD_PULSE(3))
+
+static void task (void) {
+    LOAD_PULSE(2)
+
+    __builtin_avr_delay_cycles (LOAD_WORK);
+}
+
+ISR(LOAD_TIMER_vect) {
+    if (!akat_put_task_nonatomic (task)) {
+        LOAD_PULSE(0)
+    }
+
+    if (!--events_left) {
+        LOAD_TIMER_STOP()
+        posting_done = 1;
+    }
+}
+
+__ATTR_NORETURN__
+void main () {
+    akat_init ();
+
+    DDRB = 0xF;
+
+    LOAD_TIMSK = _BV(LOAD_OCIE);
+    LOAD_TIMER_START()
+
+    sei ();
+    akat_dispatcher_loop ();
+}
@@ -0,0 +1,92 @@
+#!/usr/bin/env python
+
+# Runs load-<tasks>-<period>.avr firmwares built from load.cpp (see Makefile)
+# and reports sustained throughput, drops and enqueue-to-execution latency.
+# First 10% of executed tasks (warm-up) are not used for throughput and latency.
+# Usage: load.py mcu firmware...
+
+from simavr import *
+import sys
+
+mcu = sys.argv [1]
+files = sys.argv [2:]
+freq = 8000000
+
+# Part of the run (filling the queue) which is not measured
+warmup = 0.1
+
+f = open('load-result-' + mcu, 'aw')
+
+def percentile (values, p):
+    if not values:
+        return 0
+    values = sorted (values)
+    return values [min (len (values) - 1, len (values) * p / 100)]
+
+def run (filename):
+    avr = AVR (filename = filename, mcu = mcu, freq = freq, quiet = True)
+    state = {'stop': False}
+    posted = list ()
+    started = list ()
+    dropped = list ()
+
+    def on_posted (value, arg):
+        if value != 0:
+            posted.append (avr.cycle)
+
+    def on_started (value, arg):
+        if value != 0:
+            started.append (avr.cycle)
+
+    def on_dropped (value, arg):
+        if value != 0:
+            dropped.append (avr.cycle)
+
+    def on_exit (value, arg):
+        if value != 0:
+            state ['stop'] = True
+
+    avr.get_ioport_irq ('B', 0).register_notify (on_posted)
+    avr.get_ioport_irq ('B', 1).register_notify (on_exit)
+    avr.get_ioport_irq ('B', 2).register_notify (on_started)
+    avr.get_ioport_irq ('B', 3).register_notify (on_dropped)
+
+    while not state ['stop']:
+        avr.run_cycles ()
+
+    # Offered rate is measured from all post attempts (posted and dropped)
+    events = sorted (posted + dropped)
+    offered = (len (events) - 1) * freq / max (events [-1] - events [0], 1) if len (events) > 1 else 0
+
+    # Queue is FIFO, so n-th started task is the n-th posted one
+    skip = int (len (started) * warmup)
+    latencies = [s - p for (p, s) in zip (posted, started)] [skip:]
+    measured = started [skip:]
+    sustained = (len (measured) - 1) * freq / max (measured [-1] - measured [0], 1) if len (measured) > 1 else 0
+
+    return {
+        'executed': len (started),
+        'dropped': len (dropped),
+        'offered': offered,
+        'sustained': sustained,
+        'latency': [percentile (latencies, p) for p in (50, 90, 99, 100)]
+    }
+
+saturation = None
+
+for filename in files:
+    # load-<tasks>-<period>.avr
+    tasks, period = filename [:-4].split ('-') [1:3]
+    r = run (filename)
+
+    print >> f, ("tasks = %s, period = %s: offered = %d/s, sustained = %d/s, executed = %d, dropped = %d, "
+                 + "latency p50/p90/p99/max = %s") % (tasks, period, r ['offered'], r ['sustained'],
+                                                      r ['executed'], r ['dropped'], r ['latency'])
+
+    if r ['dropped'] == 0:
+        saturation = (period, r ['sustained'])
+
+if saturation:
+    print >> f, "tasks = %s: highest rate without drops: period = %s, sustained = %d/s" % (tasks, saturation [0], saturation [1])
+else:
+    print >> f, "tasks = %s: drops at every rate" % tasks
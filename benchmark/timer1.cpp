@@ -9,7 +9,12 @@ AKAT_DECLARE(/* cpu_frequency = */              8000000,
              /* dispatcher_idle_code = */       ,
              /* dispatcher_overflow_code = */   )
 
+// Dispatcher takes GPIOR1 and GPIOR2 if built with AKAT_GPIOR
+#if defined(AKAT_GPIOR) && defined(GPIOR2)
+AKAT_STIMER_8BIT_GPIOR (timer1, GPIOR0) {
+#else
 AKAT_STIMER_8BIT (timer1, "r15") {
+#endif
     BENCH
 }
 
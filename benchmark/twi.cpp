@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "benchmark.h"
+
+AKAT_DECLARE(/* cpu_frequency = */              8000000,
+             /* tasks = */                      8,
+             /* dispatcher_idle_code = */       ,
+             /* dispatcher_overflow_code = */   )
+
+// USI master can't be run here: simavr has no USI model.
+#ifdef TWCR
+
+AKAT_TWI_MASTER()
+
+// check.c attaches EEPROM-like slave at 0x50: first written byte is a memory address,
+// next bytes are stored from that address, reads return bytes from that address.
+static const uint8_t write_command[] = {0x10, 0xA5, 0x5A};
+static const uint8_t read_command[] = {0x10};
+static uint8_t data[2];
+
+static void done (void);
+
+static akat_twi_transaction_t write_transaction = {
+    /* address = */         0x50,
+    /* write_length = */    sizeof (write_command),
+    /* read_length = */     0,
+    /* write_buffer = */    write_command,
+    /* read_buffer = */     NULL,
+    /* done_task = */       done
+};
+
+static akat_twi_transaction_t read_transaction = {
+    /* address = */         0x50,
+    /* write_length = */    sizeof (read_command),
+    /* read_length = */     sizeof (data),
+    /* write_buffer = */    read_command,
+    /* read_buffer = */     data,
+    /* done_task = */       done
+};
+
+// Nobody is at 0x51
+static akat_twi_transaction_t missing_transaction = {
+    /* address = */         0x51,
+    /* write_length = */    0,
+    /* read_length = */     0,
+    /* write_buffer = */    NULL,
+    /* read_buffer = */     NULL,
+    /* done_task = */       done
+};
+
+static void done (void) {
+    BENCH
+
+    if (missing_transaction.status != AKAT_TWI_PENDING) {
+        BENCH_CHECK (write_transaction.status == AKAT_TWI_OK
+                     && read_transaction.status == AKAT_TWI_OK
+                     && missing_transaction.status == AKAT_TWI_NACK
+                     && !akat_twi_get_lost ()
+                     && data[0] == 0xA5 && data[1] == 0x5A)
+
+        BENCH_EXIT
+    }
+}
+
+__ATTR_NORETURN__
+void main () {
+    akat_init ();
+
+    BENCH_INIT
+
+    BENCH
+    akat_twi_init (100_khz);
+
+    BENCH
+    akat_twi_submit (&write_transaction);
+
+    BENCH
+    akat_twi_submit (&read_transaction);
+    akat_twi_submit (&missing_transaction);
+
+    BENCH
+
+    sei ();
+    akat_dispatcher_loop ();
+}
+
+#else
+
+void main () {
+    BENCH_INIT
+
+    BENCH
+
+    BENCH_EXIT
+}
+
+#endif
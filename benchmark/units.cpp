@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "benchmark.h"
+
+AKAT_DECLARE(/* cpu_frequency = */              8000000,
+             /* tasks = */                      8,
+             /* dispatcher_idle_code = */       ,
+             /* dispatcher_overflow_code = */   )
+
+AKAT_STIMERS_FREQUENCY(1_khz)
+
+static volatile uint8_t ocr;
+
+static_assert(akat_timer_prescaler (1_khz) == 64, "akat_timer_prescaler");
+static_assert(akat_timer_ocr (1_khz, 64) == 124, "akat_timer_ocr");
+static_assert(akat_timer_ocr (1_hz, 256, 65535) == 31249, "akat_timer_ocr (16 bit)");
+static_assert(akat_ticks (2_ms, 1_khz) == 2, "akat_ticks");
+static_assert(akat_cycles (10_us) == 80, "akat_cycles");
+static_assert(akat_to_frequency (10_ms).hz == 100, "akat_to_frequency");
+static_assert(akat_to_duration (1_khz).us == 1000, "akat_to_duration");
+static_assert(akat_stimers_clock_t::frequency ().hz == 1000, "AKAT_STIMERS_FREQUENCY");
+
+AKAT_STIMER_8BIT (timer1, "r15") {
+    BENCH
+}
+
+void main () {
+    akat_init ();
+
+    BENCH_INIT
+
+    BENCH
+    timer1.set (2_ms);
+
+    BENCH
+    ocr = akat_timer_ocr (1_khz, akat_timer_prescaler (1_khz));
+
+    BENCH
+    akat_delay (10_us);
+
+    BENCH
+    akat_trigger_stimers (timer1);
+
+    akat_trigger_stimers (timer1);
+
+    BENCH
+
+    BENCH_EXIT
+}
@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////
+// Useful functions for rapid development for AVR microcontrollers.
+// 2010 (C) Akshaal
+// http://www.akshaal.info    or    http://rus.akshaal.info
+// GNU GPL
+///////////////////////////////////////////////////////////////////
+
+// ADC
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#ifdef ADCSRA
+
+/**
+ * Interrupt driven ADC sampling pipeline. Instantiated by AKAT_ADC macro.
+ *
+ * Conversions are started from the ADC completion interrupt. 4^oversampling_log2 samples
+ * are accumulated for a channel, decimated into one reading with (10 + oversampling_log2) bits
+ * of resolution and then the next channel from the list is selected.
+ * Readings are stored into one half of a double buffer. When the half is full,
+ * buffers are swapped and block_task is posted to the dispatcher.
+ */
+template<uint8_t oversampling_log2, uint8_t block, uint8_t admux, uint8_t prescaler,
+         akat_task_t block_task, uint8_t... Channels>
+struct akat_adc_t {
+    static_assert(sizeof...(Channels) > 0, "ADC channel list must not be empty");
+    static_assert(oversampling_log2 <= 3, "ADC oversampling_log2 must be 0..3 (16 bit accumulator)");
+    static_assert(block > 0, "ADC block must contain at least one reading");
+    static_assert(block * sizeof...(Channels) <= 255, "ADC block is too large");
+
+    static constexpr uint8_t channels = sizeof...(Channels);
+    static constexpr uint8_t samples = 1 << (2 * oversampling_log2);
+    static constexpr uint8_t readings = block * channels;
+
+    uint16_t buffers[2][readings];
+    uint16_t accumulator;
+    uint8_t samples_left;
+    uint8_t channel;
+    uint8_t position;
+    uint8_t writing;
+    uint8_t overruns;
+    volatile uint8_t pending;
+
+    FORCE_INLINE static uint8_t channel_mux (uint8_t idx) {
+        static const uint8_t muxes[] = {Channels...};
+        return muxes[idx];
+    }
+
+    /**
+     * Start conversions from the first channel of the list.
+     */
+    FORCE_INLINE void start () {
+        accumulator = 0;
+        samples_left = samples;
+        channel = 0;
+        position = 0;
+
+        ADMUX = admux | channel_mux (0);
+        ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADSC) | prescaler;
+    }
+
+    /**
+     * Stop conversions and turn ADC off.
+     */
+    FORCE_INLINE void stop () {
+        ADCSRA = 0;
+    }
+
+    /**
+     * Returns block that is ready to be processed. Readings are interleaved:
+     * block[reading * channels + channel].
+     */
+    FORCE_INLINE const uint16_t *get_block () {
+        return buffers[writing ^ 1];
+    }
+
+    /**
+     * Must be called by block_task when it is done with the block returned by get_block.
+     */
+    FORCE_INLINE void release () {
+        pending = 0;
+    }
+
+    /**
+     * Returns number of blocks discarded because previous block was not released in time
+     * or dispatcher queue was full.
+     */
+    FORCE_INLINE uint8_t get_overruns () {
+        return overruns;
+    }
+
+    /**
+     * Body of the ADC completion interrupt.
+     */
+    FORCE_INLINE void isr () {
+        accumulator += ADC;
+
+        if (!--samples_left) {
+            // Decimation with rounding
+            uint16_t reading = accumulator;
+            if (oversampling_log2) {
+                reading = (reading + (1 << (oversampling_log2 - 1))) >> oversampling_log2;
+            }
+
+            buffers[writing][position] = reading;
+
+            accumulator = 0;
+            samples_left = samples;
+
+            if (++channel == channels) {
+                channel = 0;
+            }
+
+            if (channels > 1) {
+                ADMUX = admux | channel_mux (channel);
+            }
+
+            if (++position == readings) {
+                position = 0;
+
+                if (pending || akat_put_task_nonatomic (block_task)) {
+                    // Block is lost, fill the same half once again
+                    overruns++;
+                } else {
+                    pending = 1;
+                    writing ^= 1;
+                }
+            }
+        }
+
+        ADCSRA |= _BV(ADSC);
+    }
+};
+
+#endif
@@ -11,7 +11,7 @@
 #include <stdlib.h>
 
 // Registered used by akat:
-//    r4, r5, r6 - dispatcher
+//    r4, r5, r6 - dispatcher (GPIOR1, GPIOR2 instead if built with AKAT_GPIOR and MCU has them)
 
 #define FORCE_INLINE    __attribute__((always_inline)) inline
 #define NO_INLINE       __attribute__((noinline))
@@ -28,7 +28,7 @@
     volatile akat_task_t g_akat_tasks[tasks];                                          \
                                                                                        \
     /* CPU freq */                                                                     \
-    static FORCE_INLINE uint32_t akat_cpu_freq_hz()  {                                 \
+    static FORCE_INLINE constexpr uint32_t akat_cpu_freq_hz()  {                       \
         return cpu_freq;                                                               \
     }                                                                                  \
                                                                                        \
@@ -76,12 +76,14 @@ static FORCE_INLINE uint8_t is_akat_debug_on () {return 0;} __ATTR_CONST__ __ATT
 #endif
 
 // Returns cpu frequency HZ.
-static uint32_t akat_cpu_freq_hz () __ATTR_CONST__ __ATTR_PURE__;
+static constexpr uint32_t akat_cpu_freq_hz () __ATTR_CONST__ __ATTR_PURE__;
 
-// Convert usecs to frequency
+// Convert usecs to frequency.
+// Performs 32-bit division in runtime unless argument is constant, prefer akat_to_frequency.
 #define usecs2freq(usecs) (((uint32_t)1000000) / ((uint32_t)(usecs)))
 
 // Convert frequency to usecs
+// Performs 32-bit division in runtime unless argument is constant, prefer akat_to_duration.
 #define freq2usecs(freq) (((uint32_t)1000000) / ((uint32_t)(freq)))
 
 // Misc. Concatenate two names
@@ -91,6 +93,127 @@ static uint32_t akat_cpu_freq_hz () __ATTR_CONST__ __ATTR_PURE__;
 #define AKAT_INC_REG(reg) asm ("inc %0" : "+r" (reg));
 #define AKAT_DEC_REG(reg) asm ("dec %0" : "+r" (reg));
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Time units
+//
+// Durations and frequencies are written with literals (10_us, 5_ms, 1_s, 100_hz, 8_mhz)
+// and converted to cycles, ticks and timer settings at compile time. Conversions
+// fail to compile if result overflows or can't be represented exactly.
+
+__attribute__((error("Time unit conversion overflows!")))
+extern void akat_time_error_overflow__ ();
+
+__attribute__((error("Time unit conversion loses precision!")))
+extern void akat_time_error_precision__ ();
+
+__attribute__((error("Time units must be used with -O compiler flag and constant argument!")))
+extern void akat_time_error_nc__ ();
+
+__attribute__((error("Duration is shorter than one tick!")))
+extern void akat_time_error_zero__ ();
+
+// Duration in microseconds.
+struct akat_duration_t {
+    uint32_t us;
+};
+
+// Frequency in Hz.
+struct akat_frequency_t {
+    uint32_t hz;
+};
+
+static constexpr uint32_t akat_time_u32__ (uint64_t value) {
+    if (value > 0xFFFFFFFFUL) {
+        akat_time_error_overflow__ ();
+    }
+
+    return value;
+}
+
+static constexpr uint32_t akat_time_div__ (uint64_t a, uint64_t b) {
+    if (b == 0 || a % b) {
+        akat_time_error_precision__ ();
+    }
+
+    return akat_time_u32__ (a / b);
+}
+
+constexpr akat_duration_t operator"" _us (unsigned long long us) {
+    return akat_duration_t {akat_time_u32__ (us)};
+}
+
+constexpr akat_duration_t operator"" _ms (unsigned long long ms) {
+    return akat_duration_t {akat_time_u32__ (ms * 1000)};
+}
+
+constexpr akat_duration_t operator"" _s (unsigned long long s) {
+    return akat_duration_t {akat_time_u32__ (s * 1000000)};
+}
+
+constexpr akat_frequency_t operator"" _hz (unsigned long long hz) {
+    return akat_frequency_t {akat_time_u32__ (hz)};
+}
+
+constexpr akat_frequency_t operator"" _khz (unsigned long long khz) {
+    return akat_frequency_t {akat_time_u32__ (khz * 1000)};
+}
+
+constexpr akat_frequency_t operator"" _mhz (unsigned long long mhz) {
+    return akat_frequency_t {akat_time_u32__ (mhz * 1000000)};
+}
+
+// Period of the given duration as a frequency.
+static constexpr akat_frequency_t akat_to_frequency (akat_duration_t period) {
+    return akat_frequency_t {akat_time_div__ (1000000, period.us)};
+}
+
+// Period of the given frequency as a duration.
+static constexpr akat_duration_t akat_to_duration (akat_frequency_t freq) {
+    return akat_duration_t {akat_time_div__ (1000000, freq.hz)};
+}
+
+// Number of ticks of the clock with frequency 'clock' in the given duration.
+static constexpr uint32_t akat_ticks (akat_duration_t duration, akat_frequency_t clock) {
+    return akat_time_div__ ((uint64_t)duration.us * clock.hz, 1000000);
+}
+
+// Number of cpu cycles in the given duration.
+static constexpr uint32_t akat_cycles (akat_duration_t duration) {
+    return akat_ticks (duration, akat_frequency_t {akat_cpu_freq_hz ()});
+}
+
+// Value for OCR register of a hardware timer in CTC mode to get compare match with
+// the given frequency. max is 255 for 8-bit timers and 65535 for 16-bit timers.
+static constexpr uint16_t akat_timer_ocr (akat_frequency_t freq, uint16_t prescaler, uint16_t max = 255) {
+    uint32_t counts = akat_time_div__ (akat_cpu_freq_hz (), (uint64_t)prescaler * freq.hz);
+
+    if (counts == 0 || counts - 1 > max) {
+        akat_time_error_overflow__ ();
+    }
+
+    return counts - 1;
+}
+
+// The smallest prescaler (one of 1, 8, 64, 256, 1024 as for timer0 and timer1) with
+// which akat_timer_ocr gives exact value not exceeding max.
+static constexpr uint16_t akat_timer_prescaler (akat_frequency_t freq, uint16_t max = 255) {
+    const uint16_t prescalers[] = {1, 8, 64, 256, 1024};
+
+    for (uint8_t i = 0; freq.hz && i < sizeof (prescalers) / sizeof (prescalers[0]); i++) {
+        uint64_t divider = (uint64_t)prescalers[i] * freq.hz;
+
+        if (akat_cpu_freq_hz () % divider == 0
+                && akat_cpu_freq_hz () >= divider
+                && akat_cpu_freq_hz () / divider - 1 <= max)
+        {
+            return prescalers[i];
+        }
+    }
+
+    akat_time_error_overflow__ ();
+    return 0;
+}
+
 // Delay. Delay function is non atomic!
 // Routines are borrowed from avr-lib
 __attribute__((error("akat_delay_us and akat_delay_us must be used with -O compiler flag and constant argument!")))
@@ -138,6 +261,10 @@ FORCE_INLINE void akat_delay_ms (uint16_t ms) {
     akat_delay_us (1000L * (uint32_t)ms);
 }
 
+static FORCE_INLINE void akat_delay (akat_duration_t duration) {
+    akat_delay_us (duration.us);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Debug
 
@@ -279,29 +406,82 @@ inline void akat_trigger_stimers (Timer1 &timer1, Timer2 &timer2, Timer3 &timer3
     }
 };
 
+// Declared by AKAT_STIMERS_FREQUENCY.
+struct akat_stimers_clock_t;
+
+// Declare frequency of akat_trigger_stimers calls. Required to set soft timers with
+// durations, e.g. timer.set (10_ms).
+#define AKAT_STIMERS_FREQUENCY(freq)                                          \
+    struct akat_stimers_clock_t {                                             \
+        static FORCE_INLINE constexpr akat_frequency_t frequency () {         \
+            return freq;                                                      \
+        }                                                                     \
+    };
+
+/**
+ * Convert duration to number of ticks for 8-bit soft timer.
+ */
+template<typename Clock>
+FORCE_INLINE uint8_t akat_stimer_ticks (akat_duration_t duration) {
+    if (!__builtin_constant_p (duration.us)) {
+        akat_time_error_nc__ ();
+    }
+
+    uint32_t ticks = akat_ticks (duration, Clock::frequency ());
+
+    // Zero ticks would cancel the timer
+    if (ticks == 0) {
+        akat_time_error_zero__ ();
+    }
+
+    if (ticks > 255) {
+        akat_time_error_overflow__ ();
+    }
+
+    return ticks;
+}
+
+// Soft timer with counter kept in a global register, e.g. "r15".
 #define AKAT_STIMER_8BIT(name, reg)                                           \
     register uint8_t __soft_timer_##name##_counter__ asm(reg);                \
                                                                               \
+    AKAT_STIMER_8BIT_BODY__(name, __soft_timer_##name##_counter__)
+
+// Soft timer with counter kept in a general purpose I/O register, e.g. GPIOR0.
+// This way no global register is reserved. Counter is read and written once per tick.
+#define AKAT_STIMER_8BIT_GPIOR(name, gpior)                                   \
+    AKAT_STIMER_8BIT_BODY__(name, gpior)
+
+#define AKAT_STIMER_8BIT_BODY__(name, counter)                                \
     FORCE_INLINE void __soft_timer_##name##_f__ ();                           \
                                                                               \
     struct name##_t {                                                         \
         FORCE_INLINE void set (uint8_t time) {                                \
-            __soft_timer_##name##_counter__ = time;                           \
+            counter = time;                                                   \
+        }                                                                     \
+                                                                              \
+        template<typename Clock = akat_stimers_clock_t>                       \
+        FORCE_INLINE void set (akat_duration_t time) {                        \
+            set (akat_stimer_ticks<Clock> (time));                            \
         }                                                                     \
                                                                               \
         FORCE_INLINE uint8_t get (uint8_t time) {                             \
-            return __soft_timer_##name##_counter__;                           \
+            return counter;                                                   \
         }                                                                     \
                                                                               \
         FORCE_INLINE void cancel () {                                         \
-            __soft_timer_##name##_counter__ = 0;                              \
+            counter = 0;                                                      \
         }                                                                     \
                                                                               \
         FORCE_INLINE uint8_t decrement_and_check () {                         \
-            if (__soft_timer_##name##_counter__) {                            \
-                AKAT_DEC_REG (__soft_timer_##name##_counter__);               \
-                return __soft_timer_##name##_counter__;                       \
+            uint8_t value = counter;                                          \
+                                                                              \
+            if (value) {                                                      \
+                AKAT_DEC_REG (value);                                         \
+                counter = value;                                              \
+                return value;                                                 \
             }                                                                 \
+                                                                              \
             return 1;                                                         \
         }                                                                     \
                                                                               \
@@ -312,6 +492,60 @@ inline void akat_trigger_stimers (Timer1 &timer1, Timer2 &timer2, Timer3 &timer3
                                                                               \
     FORCE_INLINE void __soft_timer_##name##_f__ ()
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// ADC
+
+// Declare interrupt driven ADC sampling pipeline (see akat_adc_t in adc.cpp).
+// name - name of the object used to control the pipeline (name.start (), name.get_block (), ...)
+// oversampling_log2 - 4^oversampling_log2 samples are decimated into one reading (allowed values: 0..3)
+// block - number of readings per channel collected before block_task is posted
+// admux - reference selection and other ADMUX bits to be or'ed with channel mux value
+// prescaler - ADPS bits of ADCSRA
+// block_task - dispatcher task to post when a block is ready. Task must call name.release ()
+// ... - list of channels (ADMUX mux values)
+#define AKAT_ADC(name, oversampling_log2, block, admux, prescaler, block_task, ...)  \
+    static void block_task ();                                                        \
+                                                                                      \
+    akat_adc_t<oversampling_log2, block, admux, prescaler,                            \
+               block_task, __VA_ARGS__> name;                                         \
+                                                                                      \
+    ISR(ADC_vect) {                                                                   \
+        name.isr ();                                                                  \
+    }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// TWI (I2C) master
+
+// Status of akat_twi_transaction_t (see twi.cpp)
+#define AKAT_TWI_PENDING        0
+#define AKAT_TWI_OK             1
+#define AKAT_TWI_NACK           2
+#define AKAT_TWI_ERROR          3
+
+// Declare interrupt driven TWI master. Transactions are queued with akat_twi_submit.
+// akat_twi_init must be called to set SCL frequency.
+// On MCUs without TWI module (attiny85, attiny2313) USI is used and Timer0 is reserved for SCL.
+#define AKAT_TWI_MASTER()                                                             \
+    ISR(AKAT_TWI_vect) {                                                              \
+        akat_twi_isr ();                                                              \
+    }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// EEPROM
+
+// Declare EEPROM write-behind queue (see akat_eeprom_t in eeprom.cpp).
+// name - name of the object used to access EEPROM (name.write (addr, value), name.read (addr))
+// queue_size - number of bytes in queue (allowed values: 1, 2, 4, 8, 16, 32)
+// flush_task - dispatcher task to post when all queued bytes are written
+#define AKAT_EEPROM(name, queue_size, flush_task)                                     \
+    static void flush_task ();                                                        \
+                                                                                      \
+    akat_eeprom_t<queue_size, flush_task> name;                                       \
+                                                                                      \
+    ISR(AKAT_EE_READY_vect) {                                                         \
+        name.isr ();                                                                  \
+    }
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // GPIO
 
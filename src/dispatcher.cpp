@@ -8,9 +8,17 @@
 // Dispatching
 
 #include <stdlib.h>
+#include <avr/io.h>
 #include <avr/interrupt.h>
 #include <util/atomic.h>
 
+// Build with AKAT_GPIOR defined to keep dispatcher state in GPIOR1 and GPIOR2
+// on MCUs that have them. Registers r4, r5, r6 are used otherwise.
+// GPIOR0 is left for the application: on most MCUs it's the only GPIOR within sbi/cbi reach.
+#if defined(AKAT_GPIOR) && defined(GPIOR2)
+#define AKAT_DISPATCHER_GPIOR
+#endif
+
 // This is defined by user to provide mask for tasks count
 static uint8_t akat_dispatcher_tasks_mask() __ATTR_PURE__ __ATTR_CONST__;
 
@@ -26,15 +34,28 @@ extern volatile akat_task_t g_akat_tasks[];
 
 // We use indexes, not pointers, because indexes are smaller (1 bytes) than pointers (2 bytes).
 // Code is much smaller this way (version with pointer were evaluated).
+#ifdef AKAT_DISPATCHER_GPIOR
+// Indexes are kept in general purpose I/O registers (single cycle in/out),
+// mask is a constant, so no registers are reserved.
+#define g_free_slot     GPIOR1
+#define g_filled_slot   GPIOR2
+#define g_slots         akat_dispatcher_tasks_mask()
+#else
 register uint8_t g_free_slot asm("r4");;
 register uint8_t g_filled_slot asm("r5");
 register uint8_t g_slots asm("r6");
+#endif
 
 /**
  * Initialize disptacher.
  */
 static void akat_init_dispatcher() {
+#ifdef AKAT_DISPATCHER_GPIOR
+    g_free_slot = 0;
+    g_filled_slot = 0;
+#else
     g_slots = akat_dispatcher_tasks_mask();
+#endif
 }
 
 /**
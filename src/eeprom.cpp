@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////
+// Useful functions for rapid development for AVR microcontrollers.
+// 2010 (C) Akshaal
+// http://www.akshaal.info    or    http://rus.akshaal.info
+// GNU GPL
+///////////////////////////////////////////////////////////////////
+
+// EEPROM
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#ifdef EECR
+
+// Names of EEPROM bits and vector differ between MCUs
+#ifdef EEPE
+#define AKAT_EEPE       EEPE
+#define AKAT_EEMPE      EEMPE
+#else
+#define AKAT_EEPE       EEWE
+#define AKAT_EEMPE      EEMWE
+#endif
+
+#if defined(EE_READY_vect)
+#define AKAT_EE_READY_vect      EE_READY_vect
+#elif defined(EE_RDY_vect)
+#define AKAT_EE_READY_vect      EE_RDY_vect
+#else
+#define AKAT_EE_READY_vect      EEPROM_READY_vect
+#endif
+
+/**
+ * EEPROM write-behind queue. Instantiated by AKAT_EEPROM macro.
+ *
+ * Writes are queued in SRAM and drained from EE_READY interrupt, one byte per interrupt.
+ * Byte is read back before writing and is not written if it is unchanged.
+ * Byte being written stays in the queue until the write is done, so it takes a slot
+ * and reads of its address are served from SRAM.
+ * flush_task is posted to the dispatcher when queue becomes empty and the last write is done.
+ * If dispatcher queue is full at that moment, flush_task is lost (see get_lost_flushes).
+ *
+ * Queue holds up to size bytes. write and read scan the queue with interrupts disabled,
+ * so interrupt latency grows with the queue size (about 10 cycles per pending byte).
+ */
+template<uint8_t size, akat_task_t flush_task>
+struct akat_eeprom_t {
+    static_assert(size && !(size & (size - 1)) && size <= 32,
+                  "EEPROM queue size must be one of the following: 1,2,4,8,16,32");
+
+    struct entry_t {
+        uint16_t address;
+        uint8_t value;
+    };
+
+    entry_t entries[size];
+
+    // Free running indexes, masked on access. tail - head is number of pending bytes.
+    uint8_t head;
+    uint8_t tail;
+
+    // Set if entry at head is being written. It's removed by the next EE_READY interrupt.
+    uint8_t writing;
+
+    uint8_t writes;
+    uint8_t lost_flushes;
+
+    /**
+     * Returns pointer to the pending entry for the address or NULL.
+     * Entry being written is not considered. Must be used with interrupts disabled.
+     */
+    FORCE_INLINE entry_t *find (uint16_t address) {
+        for (uint8_t i = head + writing; i != tail; i++) {
+            entry_t *entry = &entries[i & (size - 1)];
+
+            if (entry->address == address) {
+                return entry;
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+     * Queue byte for writing. Pending write to the same address is replaced
+     * (unless that byte is being written already, then it's queued once again).
+     * Returns 1 if byte was discarded (because queue is full).
+     */
+    uint8_t write (uint16_t address, uint8_t value) {
+        uint8_t rc = 0;
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            entry_t *entry = find (address);
+
+            if (entry) {
+                entry->value = value;
+            } else if ((uint8_t)(tail - head) == size) {
+                rc = 1;
+            } else {
+                entry = &entries[tail & (size - 1)];
+                entry->address = address;
+                entry->value = value;
+                tail++;
+
+                EECR |= _BV(EERIE);
+            }
+        }
+
+        return rc;
+    }
+
+    /**
+     * Read byte. Pending bytes (including the one being written) are served from the queue.
+     * Reading of any other address blocks until write in progress (if any) is done,
+     * that is up to 3.4 ms for a single byte.
+     */
+    uint8_t read (uint16_t address) {
+        while (1) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                entry_t *entry = find (address);
+
+                if (!entry && writing) {
+                    entry = &entries[head & (size - 1)];
+
+                    if (entry->address != address) {
+                        entry = 0;
+                    }
+                }
+
+                if (entry) {
+                    return entry->value;
+                }
+
+                if (bit_is_clear (EECR, AKAT_EEPE)) {
+                    EEAR = address;
+                    EECR |= _BV(EERE);
+                    return EEDR;
+                }
+            }
+        }
+    }
+
+    /**
+     * Returns 1 if there are no pending writes.
+     */
+    FORCE_INLINE uint8_t is_flushed () {
+        return bit_is_clear (EECR, EERIE);
+    }
+
+    /**
+     * Returns number of bytes actually written to EEPROM (unchanged bytes are not written).
+     * Wraps around.
+     */
+    FORCE_INLINE uint8_t get_writes () {
+        return writes;
+    }
+
+    /**
+     * Returns number of times flush_task was not posted because dispatcher queue was full.
+     * Use is_flushed to find out whether queue is flushed.
+     */
+    FORCE_INLINE uint8_t get_lost_flushes () {
+        return lost_flushes;
+    }
+
+    /**
+     * Body of the EE_READY interrupt.
+     */
+    FORCE_INLINE void isr () {
+        if (writing) {
+            writing = 0;
+            head++;
+        }
+
+        if (head == tail) {
+            EECR &= ~_BV(EERIE);
+
+            if (akat_put_task_nonatomic (flush_task)) {
+                lost_flushes++;
+            }
+            return;
+        }
+
+        entry_t *entry = &entries[head & (size - 1)];
+
+        EEAR = entry->address;
+        EECR |= _BV(EERE);
+
+        if (EEDR != entry->value) {
+            EEDR = entry->value;
+            EECR |= _BV(AKAT_EEMPE);
+            EECR |= _BV(AKAT_EEPE);
+
+            writing = 1;
+            writes++;
+        } else {
+            // Interrupt fires again at once for the next entry
+            head++;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////
+// Useful functions for rapid development for AVR microcontrollers.
+// 2010 (C) Akshaal
+// http://www.akshaal.info    or    http://rus.akshaal.info
+// GNU GPL
+///////////////////////////////////////////////////////////////////
+
+// TWI (I2C) master
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+// Hardware TWI module is used if MCU has one. Otherwise USI is used with Timer0 in CTC mode
+// generating SCL: compare match interrupt strobes SCL every half of SCL period.
+#if defined(TWCR)
+#define AKAT_TWI_HW
+#define AKAT_TWI_vect           TWI_vect
+#elif defined(USICR) && (defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__))
+#define AKAT_TWI_USI
+#define AKAT_TWI_vect           TIMER0_COMPA_vect
+#define AKAT_USI_PORT           PORTB
+#define AKAT_USI_DDR            DDRB
+#define AKAT_USI_PIN            PINB
+#define AKAT_USI_SDA            PB0
+#define AKAT_USI_SCL            PB2
+#elif defined(USICR) && (defined(__AVR_ATtiny2313__) || defined(__AVR_ATtiny2313A__) || defined(__AVR_ATtiny4313__))
+#define AKAT_TWI_USI
+#define AKAT_TWI_vect           TIMER0_COMPA_vect
+#define AKAT_USI_PORT           PORTB
+#define AKAT_USI_DDR            DDRB
+#define AKAT_USI_PIN            PINB
+#define AKAT_USI_SDA            PB5
+#define AKAT_USI_SCL            PB7
+#endif
+
+#if defined(AKAT_TWI_HW) || defined(AKAT_TWI_USI)
+
+#ifdef AKAT_TWI_HW
+#include <util/twi.h>
+#endif
+
+/**
+ * TWI transaction. Memory (including buffers) is owned by caller and must stay
+ * untouched until status becomes something other than AKAT_TWI_PENDING.
+ * write_length bytes are written first, then read_length bytes are read after repeated start.
+ */
+struct akat_twi_transaction_t {
+    uint8_t address;                        // 7-bit slave address
+    uint8_t write_length;
+    uint8_t read_length;
+    const uint8_t *write_buffer;
+    uint8_t *read_buffer;
+    akat_task_t done_task;                  // posted to dispatcher on completion (may be NULL)
+    volatile uint8_t status;
+    akat_twi_transaction_t *next;           // used by queue
+};
+
+/**
+ * Queue transaction. Completion task of the transaction is posted when transaction
+ * is done, status of the transaction tells the result.
+ */
+static void akat_twi_submit (akat_twi_transaction_t *transaction) __ATTR_UNUSED__;
+
+static void akat_twi_finish (uint8_t status) __ATTR_UNUSED__;
+
+static akat_twi_transaction_t *g_akat_twi_head;
+static akat_twi_transaction_t *g_akat_twi_tail;
+static uint8_t g_akat_twi_position;
+static uint8_t g_akat_twi_reading;
+static uint8_t g_akat_twi_lost;
+
+__attribute__((error("akat_twi_init must be used with -O compiler flag and constant argument!")))
+extern void akat_twi_error_nc__ ();
+
+__attribute__((error("akat_twi_init can't provide such an SCL frequency!")))
+extern void akat_twi_error_freq__ ();
+
+__attribute__((error("akat_twi_init: TWBR must be 10 or higher in master mode on this MCU, SCL frequency is too high!")))
+extern void akat_twi_error_twbr__ ();
+
+/**
+ * Start transaction at the head of the queue.
+ */
+static FORCE_INLINE void akat_twi_begin () {
+    g_akat_twi_position = 0;
+    g_akat_twi_reading = !g_akat_twi_head->write_length && g_akat_twi_head->read_length;
+}
+
+#ifdef AKAT_TWI_HW
+
+/**
+ * Initialize TWI master with the given SCL frequency.
+ */
+static FORCE_INLINE void akat_twi_init (akat_frequency_t scl) {
+    if (!__builtin_constant_p (scl.hz)) {
+        akat_twi_error_nc__ ();
+    }
+
+    // SCL = F_CPU / (16 + 2 * TWBR), TWPS = 0
+    uint32_t cycles = akat_time_div__ (akat_cpu_freq_hz (), scl.hz);
+
+    if (cycles < 16 || (cycles - 16) % 2 || (cycles - 16) / 2 > 255) {
+        akat_twi_error_freq__ ();
+    }
+
+#if defined(__AVR_ATmega8__) || defined(__AVR_ATmega16__) || defined(__AVR_ATmega32__) \
+    || defined(__AVR_ATmega64__) || defined(__AVR_ATmega128__)
+    // Datasheet requirement for master mode
+    if ((cycles - 16) / 2 < 10) {
+        akat_twi_error_twbr__ ();
+    }
+#endif
+
+    TWSR = 0;
+    TWBR = (cycles - 16) / 2;
+}
+
+/**
+ * Send STOP and START of the next transaction if any. Must be used with interrupts disabled.
+ */
+static FORCE_INLINE void akat_twi_stop () {
+    if (g_akat_twi_head) {
+        // STOP followed by START
+        TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+    } else {
+        TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+    }
+}
+
+/**
+ * Start processing of the queue which was empty. Must be used with interrupts disabled.
+ */
+static FORCE_INLINE void akat_twi_wakeup () {
+    // STOP of the previous transaction might be still in progress (half of SCL period).
+    // TWSTO is kept then, so it becomes STOP followed by START like in akat_twi_stop.
+    TWCR = (TWCR & _BV(TWSTO)) | _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+}
+
+/**
+ * Body of the TWI interrupt.
+ */
+static FORCE_INLINE void akat_twi_isr () {
+    akat_twi_transaction_t *transaction = g_akat_twi_head;
+
+    switch (TW_STATUS) {
+        case TW_START:
+            akat_twi_begin ();
+            // Falls through
+
+        case TW_REP_START:
+            TWDR = (transaction->address << 1) | (g_akat_twi_reading ? TW_READ : TW_WRITE);
+            TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+            break;
+
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (g_akat_twi_position < transaction->write_length) {
+                TWDR = transaction->write_buffer [g_akat_twi_position++];
+                TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+            } else if (transaction->read_length) {
+                g_akat_twi_reading = 1;
+                g_akat_twi_position = 0;
+                TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+            } else {
+                akat_twi_finish (AKAT_TWI_OK);
+            }
+            break;
+
+        case TW_MR_DATA_ACK:
+            transaction->read_buffer [g_akat_twi_position++] = TWDR;
+            // Falls through
+
+        case TW_MR_SLA_ACK:
+            if (g_akat_twi_position + 1 < transaction->read_length) {
+                TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);
+            } else {
+                // NACK the last byte
+                TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+            }
+            break;
+
+        case TW_MR_DATA_NACK:
+            transaction->read_buffer [g_akat_twi_position] = TWDR;
+            akat_twi_finish (AKAT_TWI_OK);
+            break;
+
+        case TW_MT_SLA_NACK:
+        case TW_MR_SLA_NACK:
+        case TW_MT_DATA_NACK:
+            akat_twi_finish (AKAT_TWI_NACK);
+            break;
+
+        case TW_MT_ARB_LOST:
+            // Start again as soon as bus is free
+            TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+            break;
+
+        default:
+            akat_twi_finish (AKAT_TWI_ERROR);
+    }
+}
+
+#endif
+
+#ifdef AKAT_TWI_USI
+
+// USI master states. Every state is one tick of Timer0 (half of SCL period).
+#define AKAT_USI_IDLE           0
+#define AKAT_USI_START          1       // SCL is high: pull SDA low
+#define AKAT_USI_ADDRESS        2       // SCL is high: pull SCL low, load address
+#define AKAT_USI_TX             3       // Clocking byte out
+#define AKAT_USI_ACK_IN         4       // Clocking ACK in
+#define AKAT_USI_RX             5       // Clocking byte in
+#define AKAT_USI_ACK_OUT        6       // Clocking ACK out
+#define AKAT_USI_REP_START      7       // SCL is low, SDA is released: release SCL
+#define AKAT_USI_STOP           8       // SCL is low, SDA is low: release SCL
+#define AKAT_USI_STOP_SDA       9       // SCL is high: release SDA
+
+static uint8_t g_akat_twi_state;
+static uint8_t g_akat_twi_prescaler;
+
+// Two-wire mode, software clock strobe
+#define AKAT_USI_STROBE     (_BV(USIWM1) | _BV(USICS1) | _BV(USICLK) | _BV(USITC))
+
+/**
+ * Clear USI flags and set counter to overflow after the given number of SCL edges.
+ */
+static FORCE_INLINE void akat_usi_count (uint8_t edges) {
+    USISR = _BV(USISIF) | _BV(USIOIF) | _BV(USIPF) | _BV(USIDC) | ((16 - edges) & 0xF);
+}
+
+static FORCE_INLINE void akat_usi_sda_input () {
+    AKAT_USI_DDR &= ~_BV(AKAT_USI_SDA);
+}
+
+static FORCE_INLINE void akat_usi_sda_output () {
+    AKAT_USI_DDR |= _BV(AKAT_USI_SDA);
+}
+
+/**
+ * Initialize TWI master with the given SCL frequency. USI master uses Timer0,
+ * timer interrupt takes place twice per SCL period, so SCL frequency must be low enough
+ * for the CPU to handle it (e.g. 25-50 kHz at 8 MHz).
+ */
+static FORCE_INLINE void akat_twi_init (akat_frequency_t scl) {
+    if (!__builtin_constant_p (scl.hz)) {
+        akat_twi_error_nc__ ();
+    }
+
+    // Half of SCL period in cycles of prescaler 1 or 8
+    uint32_t cycles = akat_time_div__ (akat_cpu_freq_hz (), 2 * (uint64_t)scl.hz);
+    uint8_t prescaled = cycles > 256;
+
+    if (prescaled && (cycles % 8 || cycles / 8 > 256)) {
+        akat_twi_error_freq__ ();
+    }
+
+    AKAT_USI_PORT |= _BV(AKAT_USI_SDA) | _BV(AKAT_USI_SCL);
+    AKAT_USI_DDR |= _BV(AKAT_USI_SDA) | _BV(AKAT_USI_SCL);
+
+    USIDR = 0xFF;
+    USICR = _BV(USIWM1) | _BV(USICS1) | _BV(USICLK);
+    akat_usi_count (16);
+
+    TCCR0A = _BV(WGM01);
+    OCR0A = (prescaled ? cycles / 8 : cycles) - 1;
+    TIMSK |= _BV(OCIE0A);
+
+    g_akat_twi_prescaler = prescaled ? _BV(CS01) : _BV(CS00);
+}
+
+/**
+ * Send STOP. Next transaction (if any) is started when STOP is done.
+ * Must be used with interrupts disabled, SCL must be low.
+ */
+static FORCE_INLINE void akat_twi_stop () {
+    // SDA is driven low if either PORT bit or the latched MSB of USIDR is low.
+    // USIDR must be set while SCL is low, otherwise SDA stays low and STOP is not generated.
+    USIDR = 0xFF;
+    akat_usi_sda_output ();
+    AKAT_USI_PORT &= ~_BV(AKAT_USI_SDA);
+    g_akat_twi_state = AKAT_USI_STOP;
+}
+
+/**
+ * Start processing of the queue which was empty. Must be used with interrupts disabled.
+ */
+static FORCE_INLINE void akat_twi_wakeup () {
+    // If STOP is in progress, the next transaction is started when it's done
+    if (g_akat_twi_state == AKAT_USI_IDLE) {
+        akat_twi_begin ();
+        g_akat_twi_state = AKAT_USI_START;
+
+        TCNT0 = 0;
+        TCCR0B = g_akat_twi_prescaler;
+    }
+}
+
+/**
+ * Body of the Timer0 compare interrupt.
+ */
+static FORCE_INLINE void akat_twi_isr () {
+    akat_twi_transaction_t *transaction = g_akat_twi_head;
+
+    // Slave stretches clock: SCL is released but still low
+    if (bit_is_set (AKAT_USI_PORT, AKAT_USI_SCL) && bit_is_clear (AKAT_USI_PIN, AKAT_USI_SCL)) {
+        return;
+    }
+
+    switch (g_akat_twi_state) {
+        case AKAT_USI_IDLE:
+            // Compare match pending from before the timer was stopped
+            return;
+
+        case AKAT_USI_START:
+            AKAT_USI_PORT &= ~_BV(AKAT_USI_SDA);
+            g_akat_twi_state = AKAT_USI_ADDRESS;
+            return;
+
+        case AKAT_USI_ADDRESS:
+            AKAT_USI_PORT &= ~_BV(AKAT_USI_SCL);
+            USIDR = (transaction->address << 1) | g_akat_twi_reading;
+            AKAT_USI_PORT |= _BV(AKAT_USI_SDA);     // SDA follows USIDR from now on
+            akat_usi_count (16);
+            g_akat_twi_state = AKAT_USI_TX;
+            return;
+
+        case AKAT_USI_REP_START:
+            AKAT_USI_PORT |= _BV(AKAT_USI_SCL);
+            g_akat_twi_state = AKAT_USI_START;
+            return;
+
+        case AKAT_USI_STOP:
+            AKAT_USI_PORT |= _BV(AKAT_USI_SCL);
+            g_akat_twi_state = AKAT_USI_STOP_SDA;
+            return;
+
+        case AKAT_USI_STOP_SDA:
+            AKAT_USI_PORT |= _BV(AKAT_USI_SDA);
+
+            if (g_akat_twi_head) {
+                akat_twi_begin ();
+                g_akat_twi_state = AKAT_USI_START;
+            } else {
+                TCCR0B = 0;
+                g_akat_twi_state = AKAT_USI_IDLE;
+            }
+            return;
+    }
+
+    // Clocking of bits: toggle SCL, counter overflows when SCL goes low after the last bit
+    USICR = AKAT_USI_STROBE;
+
+    if (bit_is_clear (USISR, USIOIF)) {
+        return;
+    }
+
+    switch (g_akat_twi_state) {
+        case AKAT_USI_TX:
+            akat_usi_sda_input ();
+            akat_usi_count (2);
+            g_akat_twi_state = AKAT_USI_ACK_IN;
+            break;
+
+        case AKAT_USI_ACK_IN:
+            akat_usi_sda_output ();
+
+            if (USIDR & 1) {
+                akat_twi_finish (AKAT_TWI_NACK);
+            } else if (g_akat_twi_reading) {
+                akat_usi_sda_input ();
+                akat_usi_count (16);
+                g_akat_twi_state = AKAT_USI_RX;
+            } else if (g_akat_twi_position < transaction->write_length) {
+                USIDR = transaction->write_buffer [g_akat_twi_position++];
+                akat_usi_count (16);
+                g_akat_twi_state = AKAT_USI_TX;
+            } else if (transaction->read_length) {
+                USIDR = 0xFF;
+                g_akat_twi_reading = 1;
+                g_akat_twi_position = 0;
+                g_akat_twi_state = AKAT_USI_REP_START;
+            } else {
+                akat_twi_finish (AKAT_TWI_OK);
+            }
+            break;
+
+        case AKAT_USI_RX:
+            transaction->read_buffer [g_akat_twi_position++] = USIDR;
+
+            // ACK all bytes but the last one
+            USIDR = g_akat_twi_position < transaction->read_length ? 0x00 : 0xFF;
+            akat_usi_sda_output ();
+            akat_usi_count (2);
+            g_akat_twi_state = AKAT_USI_ACK_OUT;
+            break;
+
+        case AKAT_USI_ACK_OUT:
+            if (g_akat_twi_position < transaction->read_length) {
+                akat_usi_sda_input ();
+                akat_usi_count (16);
+                g_akat_twi_state = AKAT_USI_RX;
+            } else {
+                akat_twi_finish (AKAT_TWI_OK);
+            }
+            break;
+    }
+}
+
+#endif
+
+/**
+ * Returns number of completion tasks that were not posted because dispatcher queue was full.
+ * Status of such transactions is set as usual.
+ */
+static FORCE_INLINE uint8_t akat_twi_get_lost () {
+    return g_akat_twi_lost;
+}
+
+/**
+ * Complete current transaction, post its task and start the next one if any.
+ * Must be used with interrupts disabled.
+ */
+static void akat_twi_finish (uint8_t status) {
+    akat_twi_transaction_t *transaction = g_akat_twi_head;
+
+    g_akat_twi_head = transaction->next;
+    if (!g_akat_twi_head) {
+        g_akat_twi_tail = 0;
+    }
+
+    transaction->status = status;
+
+    if (transaction->done_task && akat_put_task_nonatomic (transaction->done_task)) {
+        g_akat_twi_lost++;
+    }
+
+    akat_twi_stop ();
+}
+
+/**
+ * Queue transaction. Completion task of the transaction is posted when transaction
+ * is done, status of the transaction tells the result.
+ */
+static void akat_twi_submit (akat_twi_transaction_t *transaction) {
+    transaction->status = AKAT_TWI_PENDING;
+    transaction->next = 0;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (g_akat_twi_tail) {
+            g_akat_twi_tail->next = transaction;
+            g_akat_twi_tail = transaction;
+        } else {
+            g_akat_twi_head = transaction;
+            g_akat_twi_tail = transaction;
+
+            akat_twi_wakeup ();
+        }
+    }
+}
+
+#endif